@@ -1,22 +1,148 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <ostream>
 #include <string>
 #include <random>
-#include <iomanip>
 #include <cmath>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "args.hxx"
 
 using namespace std;
 
-float generateRandomFloat(float start, float end, int precision, std::mt19937& gen) {
-    std::uniform_real_distribution<float> dis(start, end);
-    float raw = dis(gen);
+// Rows generated from a single random stream. Fixed, so output depends only on the seed
+// and not on the number of threads.
+constexpr int rowsPerBlock = 64;
+
+// Row blocks generated in parallel per thread before they are written out in order.
+constexpr int blocksPerThread = 4;
+
+enum class Structure {
+    Uniform,
+    Identity,
+    Banded,
+    BlockSparse
+};
+
+struct GeneratorOptions {
+    int mSize;
+    int precision;
+    float start;
+    float end;
+    Structure structure;
+    int bandWidth;
+    int blockSize;
+    float density;
+};
+
+// Mixes values into a well distributed 64-bit hash (splitmix64 finalizer).
+std::uint64_t mix(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// Independent random stream of a single row block of a single file.
+std::mt19937 blockGenerator(unsigned int seed, int fileIndex, int block) {
+    std::seed_seq sequence{ seed, static_cast<unsigned int>(fileIndex), static_cast<unsigned int>(block) };
+    return std::mt19937(sequence);
+}
+
+// Decides whether a block of a block-sparse matrix is non-zero, independently of the row streams.
+bool isBlockNonZero(unsigned int seed, int fileIndex, int blockRow, int blockCol, float density) {
+    auto hash = mix(mix(mix(seed) ^ static_cast<std::uint64_t>(fileIndex)) ^
+        ((static_cast<std::uint64_t>(blockRow) << 32) | static_cast<std::uint32_t>(blockCol)));
+    return (hash >> 11) * 0x1.0p-53 < density;
+}
+
+// Generates and formats the rows of a single row block into the buffer.
+void generateBlock(const GeneratorOptions& options, unsigned int seed, int fileIndex, int block, std::vector<char>& buffer) {
+    auto gen = blockGenerator(seed, fileIndex, block);
+    std::uniform_real_distribution<float> dis(options.start, options.end);
+    const float factor = std::pow(10.0f, options.precision);
+    // sign, integer digits of the largest float, dot, decimals and separator
+    const std::size_t maxElementChars = 48 + options.precision;
+
+    int rowsStart = block * rowsPerBlock;
+    int rowsEnd = std::min(rowsStart + rowsPerBlock, options.mSize);
+    std::size_t used = 0;
+    buffer.resize(std::max<std::size_t>(buffer.size(), std::size_t(rowsEnd - rowsStart) * options.mSize * 8));
+
+    for (int row = rowsStart; row < rowsEnd; row++) {
+        for (int col = 0; col < options.mSize; col++) {
+            bool isRandom = false;
+            float number = 0.0f;
+            switch (options.structure) {
+            case Structure::Uniform:
+                isRandom = true;
+                break;
+            case Structure::Identity:
+                number = row == col ? 1.0f : 0.0f;
+                break;
+            case Structure::Banded:
+                isRandom = std::abs(row - col) <= options.bandWidth;
+                break;
+            case Structure::BlockSparse:
+                isRandom = isBlockNonZero(seed, fileIndex, row / options.blockSize, col / options.blockSize, options.density);
+                break;
+            }
+            if (isRandom) number = std::round(dis(gen) * factor) / factor;
+            if (number == 0.0f) number = 0.0f;
 
-    float factor = std::pow(10.0f, precision);
-    return std::round(raw * factor) / factor;
+            if (buffer.size() - used < maxElementChars) buffer.resize(std::max(2 * buffer.size(), used + maxElementChars));
+            auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), number, std::chars_format::fixed, options.precision);
+            used = result.ptr - buffer.data();
+            buffer[used++] = ' ';
+        }
+        if (buffer.size() - used < 1) buffer.resize(2 * buffer.size() + 1);
+        buffer[used++] = '\n';
+    }
+    buffer.resize(used);
+}
+
+bool generateFile(const std::string& fileName, const GeneratorOptions& options, unsigned int seed, int fileIndex, int threadCount) {
+    std::ofstream File(fileName, std::ios::binary);
+    if (!File.is_open()) {
+        std::cerr << "Could not open file " << fileName << std::endl;
+        return false;
+    }
+
+    int blockCount = (options.mSize + rowsPerBlock - 1) / rowsPerBlock;
+    int waveSize = threadCount * blocksPerThread;
+    std::vector<std::vector<char>> buffers(std::min(waveSize, blockCount));
+
+    // generate a wave of blocks in parallel, then write them in order
+    for (int waveStart = 0; waveStart < blockCount; waveStart += waveSize) {
+        int waveEnd = std::min(waveStart + waveSize, blockCount);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount && waveStart + t < waveEnd; t++) {
+            threads.emplace_back([&, t]() {
+                for (int block = waveStart + t; block < waveEnd; block += threadCount) {
+                    generateBlock(options, seed, fileIndex, block, buffers[block - waveStart]);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        for (int block = waveStart; block < waveEnd; block++) {
+            const auto& buffer = buffers[block - waveStart];
+            File.write(buffer.data(), buffer.size());
+        }
+    }
+
+    File.close();
+    if (!File) {
+        std::cerr << "Could not write file " << fileName << std::endl;
+        return false;
+    }
+    return true;
 }
 
 std::string addIndexToFilename(const std::string& filename, int index) {
@@ -47,6 +173,13 @@ std::string ensureTxtExtension(const std::string& filename) {
 
 int main(int argc, char* argv[])
 {
+    std::unordered_map<std::string, Structure> structures{
+        { "uniform", Structure::Uniform },
+        { "identity", Structure::Identity },
+        { "banded", Structure::Banded },
+        { "blockSparse", Structure::BlockSparse }
+    };
+
     args::ArgumentParser parser("Generates text file(s) with n x n matrix data in standard format.");
     args::HelpFlag helpFlag(parser, "help", "Display this help menu.", { 'h', "help" });
     args::Group requiredGroup(parser, "Required arguments:", args::Group::Validators::All);
@@ -57,7 +190,12 @@ int main(int argc, char* argv[])
     args::ValueFlag<float> maxValueFlag(optionalGroup, "Max. value", "Max. value for each matrix element. Defaults to 10.", { "maxValue" }, 10.0f);
     args::ValueFlag<unsigned int> mCountFlag(optionalGroup, "Number of files", "Number of files to generate. Defaults to 1. If greater than 1, file number appended to each file name.", { "mCount" }, 1);
     args::ValueFlag<unsigned int> precisionFlag(optionalGroup, "Decimal precision", "Decimal precision. Each matrix element rounded to 'precision' decimal points.", { "precision" }, 0);
-    args::ValueFlag<unsigned int> seedFlag(optionalGroup, "Random seed value", "Random seed value. If not specified generated randomly during runtime.", { "seed" }, 0);
+    args::ValueFlag<unsigned int> seedFlag(optionalGroup, "Random seed value", "Random seed value. If not specified generated randomly during runtime. The same seed gives the same output for any number of threads.", { "seed" }, 0);
+    args::ValueFlag<unsigned int> threadsFlag(optionalGroup, "Number of threads", "Number of generating threads. Defaults to the number of hardware threads.", { "threads" }, 0);
+    args::MapFlag<std::string, Structure> structureFlag(optionalGroup, "Matrix structure", "Matrix structure: uniform (all elements random), identity, banded or blockSparse. Defaults to uniform.", { "structure" }, structures, Structure::Uniform);
+    args::ValueFlag<unsigned int> bandWidthFlag(optionalGroup, "Band width", "Number of random diagonals on each side of the main diagonal of a banded matrix. Defaults to 1.", { "bandWidth" }, 1);
+    args::ValueFlag<unsigned int> blockSizeFlag(optionalGroup, "Block size", "Block size of a block-sparse matrix. Defaults to 64.", { "blockSize" }, 64);
+    args::ValueFlag<float> densityFlag(optionalGroup, "Block density", "Fraction of random (non-zero) blocks of a block-sparse matrix. Defaults to 0.1.", { "density" }, 0.1f);
 
     try
     {
@@ -81,22 +219,25 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    int mSize = args::get(mSizeFlag);
+    GeneratorOptions options;
+    options.mSize = args::get(mSizeFlag);
+    options.precision = args::get(precisionFlag);
+    options.start = args::get(minValueFlag);
+    options.end = args::get(maxValueFlag);
+    options.structure = args::get(structureFlag);
+    options.bandWidth = args::get(bandWidthFlag);
+    options.blockSize = std::max(1u, args::get(blockSizeFlag));
+    options.density = args::get(densityFlag);
     int mCount = args::get(mCountFlag);
     std::string fileName = args::get(fileNameFlag);
-    int precision = args::get(precisionFlag);
-    float start = args::get(minValueFlag);
-    float end = args::get(maxValueFlag);
-    int seed = args::get(seedFlag);
+    unsigned int seed = args::get(seedFlag);
+    int threadCount = args::get(threadsFlag);
 
-    std::mt19937 gen;
     if (seed == 0) {
         std::random_device rd;
-        gen.seed(rd());
-    }
-    else {
-        gen.seed(seed);
+        seed = rd();
     }
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
 
     // loop for each file
     for (int i = 0; i < mCount; i++) {
@@ -106,23 +247,8 @@ int main(int argc, char* argv[])
         }
         currentFileName = ensureTxtExtension(currentFileName);
 
-        std::ofstream File(currentFileName);
-        if (!File.is_open()) {
-            std::cerr << "Could not open file " << currentFileName << std::endl;
-            return EXIT_FAILURE;
-        }
-
-        // generate file
-        for (int row = 0; row < mSize; row++) {
-            for (int col = 0; col < mSize; col++) {
-                float number = generateRandomFloat(start, end, precision, gen);     
-                if (precision == 0 && number == -0.0f) number = 0.0f;
-                File << std::fixed << std::setprecision(precision) << number << " ";
-            }
-            File << "\n";
-        }
-        File.close();
+        if (!generateFile(currentFileName, options, seed, i, threadCount)) return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
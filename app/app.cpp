@@ -1,4 +1,5 @@
 #include "matrix.h"
+#include "distributed.h"
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -6,6 +7,10 @@
 #include <string>
 #include <iomanip>
 #include <filesystem>
+#include <random>
+#include <cmath>
+#include <sstream>
+#include <vector>
 
 void printHelpMessage(const char* programName) {
     std::cerr << "*** Strassen3 ***" << std::endl; 
@@ -25,6 +30,31 @@ void printHelpMessage(const char* programName) {
         "Submatrices of sizes not greater than the value of the threshold are multiplied using trivial algorithm." << std::endl;
     std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--double" << 
         std::setw(14) << "(optional)" << "Use double precision floating point numbers" << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--mixed" <<
+        std::setw(14) << "(optional)" << "Store matrices in single precision, accumulate dot products and C_ij sums in double precision" << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--kahan" <<
+        std::setw(14) << "(optional)" << "Accumulate dot products and C_ij sums with compensated (Kahan) summation" << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--depth" <<
+        std::setw(14) << "(optional)" << "Non-negative integer value for a maximal depth of Strassen recursion (default: unlimited). " <<
+        "Deeper submatrices are multiplied using trivial algorithm." << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--tol" <<
+        std::setw(14) << "(optional)" << "Positive relative error tolerance. Maximal depth of Strassen recursion is chosen from an error estimate. " <<
+        "If even trivial algorithm exceeds it, a warning is printed." << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--check" <<
+        std::setw(14) << "(optional)" << "Positive integer number of C elements sampled to report the max. relative error against trivial algorithm" << std::endl;
+    std::cerr << std::endl << "DISTRIBUTED USAGE: " << programName << " [options] (--workers N | --nodes LIST) [--levels L1[,L2...]] A B C" << std::endl;
+    std::cerr << std::setw(4) << "" << "       or: " << programName << " [--double] [--workers N] [--nodes LIST] --serve ADDRESS" << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--workers" <<
+        std::setw(14) << "(optional)" << "Number of local worker processes connected through Unix sockets" << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--nodes" <<
+        std::setw(14) << "(optional)" << "Comma separated worker addresses, each either host:port (TCP) or unix:path" << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--levels" <<
+        std::setw(14) << "(optional)" << "Comma separated positive integers L1[,L2...] (default: 1). The top L1 Laderman levels are split into tasks " <<
+        "for the --workers and --nodes of the coordinator. Each node serving with --workers or --nodes of its own splits the next L2 levels " <<
+        "of its tasks among them, and so on (at most " << distributed::maxLevelTiers << " values). Each level multiplies the number of tasks by 23." << std::endl;
+    std::cerr << std::setw(4) << "" << std::left << std::setw(9) << "--serve" <<
+        std::setw(14) << "(optional)" << "Run as a worker accepting coordinators on the address ([host:]port or unix:path). " <<
+        "With --workers or --nodes, levels placed on this worker by the coordinator are split among them." << std::endl;
 }
 
 struct arguments {
@@ -34,9 +64,27 @@ struct arguments {
     std::string cPath;
     bool useStrassen;
     bool useDouble;
+    bool useMixed;
+    bool useKahan;
     int threshold;
+    int maxDepth;
+    double tolerance;
+    int checkSamples;
+    int localWorkers;
+    std::vector<std::string> nodes;
+    std::vector<int> levels;
+    std::string serveAddress;
 };
 
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream listStream(list);
+    for (std::string item; std::getline(listStream, item, ',');) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
 arguments processArguments(int argc, char* argv[]) {
     arguments args;
 
@@ -46,7 +94,14 @@ arguments processArguments(int argc, char* argv[]) {
 
     args.useStrassen = true;
     args.useDouble = false;
+    args.useMixed = false;
+    args.useKahan = false;
     args.threshold = 1;
+    args.maxDepth = -1;
+    args.tolerance = 0.0;
+    args.checkSamples = 0;
+    args.localWorkers = 0;
+    args.levels = { 1 };
 
     int pathCount = 0;
     std::string paths[3];
@@ -82,6 +137,93 @@ arguments processArguments(int argc, char* argv[]) {
             continue;
         }
 
+        if (strncmp(argv[i], "--mixed", 8) == 0) {
+            args.useMixed = true;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--kahan", 8) == 0) {
+            args.useKahan = true;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--depth", 8) == 0) {
+            if (i + 1 >= argc || (args.maxDepth = std::atoi(argv[i + 1])) < 0 ||
+                (args.maxDepth == 0 && strncmp(argv[i + 1], "0", 2) != 0)) {
+                std::cerr << "Expected a non-negative integer depth value." << std::endl;
+                printHelpMessage(args.programName.c_str());
+                exit(EXIT_FAILURE);
+            }
+            i++;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--tol", 6) == 0) {
+            if (i + 1 >= argc || !((args.tolerance = std::atof(argv[i + 1])) > 0.0)) {
+                std::cerr << "Expected a positive tolerance value." << std::endl;
+                printHelpMessage(args.programName.c_str());
+                exit(EXIT_FAILURE);
+            }
+            i++;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--check", 8) == 0) {
+            if (i + 1 >= argc || (args.checkSamples = std::atoi(argv[i + 1])) < 1) {
+                std::cerr << "Expected a positive integer number of sampled elements." << std::endl;
+                printHelpMessage(args.programName.c_str());
+                exit(EXIT_FAILURE);
+            }
+            i++;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--workers", 10) == 0) {
+            if (i + 1 >= argc || (args.localWorkers = std::atoi(argv[i + 1])) < 1) {
+                std::cerr << "Expected a positive integer number of workers." << std::endl;
+                printHelpMessage(args.programName.c_str());
+                exit(EXIT_FAILURE);
+            }
+            i++;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--nodes", 8) == 0) {
+            if (i + 1 >= argc || (args.nodes = splitList(argv[i + 1])).empty()) {
+                std::cerr << "Expected a comma separated list of worker addresses." << std::endl;
+                printHelpMessage(args.programName.c_str());
+                exit(EXIT_FAILURE);
+            }
+            i++;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--levels", 9) == 0) {
+            args.levels.clear();
+            if (i + 1 < argc) {
+                for (const auto& item : splitList(argv[i + 1])) args.levels.push_back(std::atoi(item.c_str()));
+            }
+            if (args.levels.empty() || int(args.levels.size()) > distributed::maxLevelTiers ||
+                *std::min_element(args.levels.begin(), args.levels.end()) < 1) {
+                std::cerr << "Expected a comma separated list of at most " << distributed::maxLevelTiers <<
+                    " positive integer numbers of levels." << std::endl;
+                printHelpMessage(args.programName.c_str());
+                exit(EXIT_FAILURE);
+            }
+            i++;
+            continue;
+        }
+
+        if (strncmp(argv[i], "--serve", 8) == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Expected a worker address." << std::endl;
+                printHelpMessage(args.programName.c_str());
+                exit(EXIT_FAILURE);
+            }
+            args.serveAddress = argv[++i];
+            continue;
+        }
+
         if (pathCount < 3) {
             paths[pathCount++] = argv[i];
         } else {
@@ -91,6 +233,39 @@ arguments processArguments(int argc, char* argv[]) {
         }
     }
 
+    if (args.useMixed && (args.useDouble || args.useKahan)) {
+        std::cerr << "Option --mixed cannot be combined with --double or --kahan." << std::endl;
+        printHelpMessage(args.programName.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    if (!args.useStrassen && (args.localWorkers > 0 || !args.nodes.empty())) {
+        std::cerr << "Option --triv cannot be combined with --workers or --nodes." << std::endl;
+        printHelpMessage(args.programName.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    if (args.maxDepth >= 0 && args.tolerance > 0.0) {
+        std::cerr << "Options --depth and --tol cannot be combined." << std::endl;
+        printHelpMessage(args.programName.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    if (!args.serveAddress.empty()) {
+        if (pathCount != 0) {
+            std::cerr << "Worker mode does not take matrix files." << std::endl;
+            printHelpMessage(args.programName.c_str());
+            exit(EXIT_FAILURE);
+        }
+        return args;
+    }
+
+    if (args.levels.size() > 1 && args.nodes.empty()) {
+        std::cerr << "Levels after the first are split by --nodes workers, none were given." << std::endl;
+        printHelpMessage(args.programName.c_str());
+        exit(EXIT_FAILURE);
+    }
+
     if (pathCount != 3) {
         std::cerr << "Input or output file(s) not specified" << std::endl;
         printHelpMessage(args.programName.c_str());
@@ -104,8 +279,52 @@ arguments processArguments(int argc, char* argv[]) {
     return args;
 }
 
+void printDistributedStats(const DistributedStats& stats) {
+    std::cout << "Distributed tasks:      " << stats.taskCount << std::endl;
+    std::cout << "Split and send time:    " << stats.sendSeconds << " s (" << stats.bytesSent << " B)" << std::endl;
+    std::cout << "Wait and receive time:  " << stats.receiveSeconds << " s (" << stats.bytesReceived << " B)" << std::endl;
+    std::cout << "Assembly time:          " << stats.assembleSeconds << " s" << std::endl;
+    std::cout << "Worker compute time:    " << stats.workerComputeSeconds << " s total, " <<
+        stats.maxWorkerComputeSeconds << " s max per worker" << std::endl;
+}
+
+// Max. relative error of sampled elements of C = A * B against trivial algorithm in extended
+// precision, relative to sum of |A_ik * B_kj| so that cancellation does not inflate it.
 template<typename T>
+double sampledRelativeError(const Matrix<T>& A, const Matrix<T>& B, const Matrix<T>& C, int samples) {
+    if (C.size() == 0) return 0.0;
+
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> dis(0, C.size() - 1);
+    double maxError = 0.0;
+    for (int sample = 0; sample < samples; sample++) {
+        int row = dis(gen);
+        int col = dis(gen);
+        long double exact = 0.0L, scale = 0.0L;
+        for (int k = 0; k < A.size(); k++) {
+            long double product = (long double)A.get(row, k) * B.get(k, col);
+            exact += product;
+            scale += std::abs(product);
+        }
+        long double error = std::abs(C.get(row, col) - exact);
+        if (error > 0.0L) maxError = std::max(maxError, double(scale > 0.0L ? error / scale : error));
+    }
+    return maxError;
+}
+
+template<typename T, typename Acc = T>
 int run(const arguments& args) {
+    if (!args.serveAddress.empty()) {
+        try {
+            runWorker<T>(args.serveAddress, args.nodes, args.localWorkers);
+        }
+        catch (const std::exception& error) {
+            std::cerr << error.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     Matrix<T> A, B;
 
     std::ifstream aFile(args.aPath);
@@ -132,15 +351,41 @@ int run(const arguments& args) {
 		printHelpMessage(args.programName.c_str());
         return EXIT_FAILURE;
 	}
+    int maxDepth = args.maxDepth;
+    if (args.tolerance > 0.0) {
+        maxDepth = Matrix<T>::template strassen3MaxDepth<Acc>(A.size(), args.threshold, args.tolerance);
+        double estimate = Matrix<T>::template strassen3ErrorEstimate<Acc>(A.size(), maxDepth);
+        std::cout << "Strassen3 recursion depth: " << maxDepth << " (estimated relative error: " << estimate << ")" << std::endl;
+        // depth 0 is the trivial algorithm, there is nothing more accurate to fall back to
+        if (estimate > args.tolerance) {
+            std::cerr << "Warning: tolerance " << args.tolerance << " cannot be met in this precision, " <<
+                "using trivial algorithm (estimated relative error: " << estimate << ")." << std::endl;
+        }
+    }
+
+    Matrix<T> C;
 	try {
-		cFile << (args.useStrassen ? strassen3(A, B, args.threshold) : (A * B));
+        if (args.localWorkers > 0 || !args.nodes.empty()) {
+            DistributedStats stats;
+            C = distributedStrassen3<T, Acc>(A, B, args.threshold, maxDepth, args.levels, args.nodes, args.localWorkers, stats);
+            printDistributedStats(stats);
+        }
+        else {
+            C = args.useStrassen ? strassen3<Acc>(A, B, args.threshold, maxDepth) : multiplyTrivial<Acc>(A, B);
+        }
 	}
 	catch (const std::runtime_error& error) {
 		std::cerr << error.what() << std::endl;
         return EXIT_FAILURE;
 	}
+	cFile << C;
 	cFile.close();
 
+    if (args.checkSamples > 0) {
+        std::cout << "Max. relative error: " << sampledRelativeError(A, B, C, args.checkSamples) <<
+            " (" << args.checkSamples << " sampled elements)" << std::endl;
+    }
+
     return EXIT_SUCCESS;
 }
 
@@ -148,5 +393,7 @@ int main(int argc, char* argv[])
 {
     auto args = processArguments(argc, argv);
 
+    if (args.useMixed) return run<float, double>(args);
+    if (args.useKahan) return args.useDouble ? run<double, Kahan<double>>(args) : run<float, Kahan<float>>(args);
     return args.useDouble ? run<double>(args) : run<float>(args);
 }
@@ -0,0 +1,606 @@
+#pragma once
+
+#include "matrix.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Coordinator/worker mode: the coordinator applies the top Laderman step(s) itself, ships
+// the operands of the resulting products to worker processes, gathers the products and
+// assembles C. Workers multiply their operands with strassen3() locally, or split them
+// further among workers of their own (placement per level).
+//
+// Addresses are either "host:port" (TCP) or "unix:path" (Unix domain socket).
+//
+// Protocol (native byte order, so all nodes must share the architecture): the coordinator
+// sends one task to an idle worker, the worker multiplies the operands and replies with the
+// result. A worker holds a single task at a time; the coordinator keeps splitting and sending
+// to the other workers while it waits. Each task carries the threshold, remaining recursion
+// depth, accumulation type and the number of levels the worker splits among its own workers.
+
+struct DistributedStats {
+    int taskCount = 0;
+    double sendSeconds = 0.0;
+    double receiveSeconds = 0.0;
+    double assembleSeconds = 0.0;
+    double workerComputeSeconds = 0.0;
+    double maxWorkerComputeSeconds = 0.0;
+    std::uint64_t bytesSent = 0;
+    std::uint64_t bytesReceived = 0;
+};
+
+namespace distributed {
+
+// Levels split by the coordinator, by its workers, by their workers...
+constexpr int maxLevelTiers = 4;
+
+} // namespace distributed
+
+#ifndef _WIN32
+
+namespace distributed {
+
+enum MessageTag : std::int32_t {
+    TaskTag = 1
+};
+
+enum Accumulation : std::int32_t {
+    StorageAccumulation = 0,
+    DoubleAccumulation = 1,
+    KahanAccumulation = 2
+};
+
+template<typename T, typename Acc>
+constexpr Accumulation accumulationOf() {
+    if constexpr (std::is_same_v<Acc, T>) return StorageAccumulation;
+    else if constexpr (std::is_same_v<Acc, double>) return DoubleAccumulation;
+    else {
+        static_assert(std::is_same_v<Acc, Kahan<T>>, "Unsupported accumulation type.");
+        return KahanAccumulation;
+    }
+}
+
+struct TaskHeader {
+    std::int32_t tag;
+    std::int32_t elementSize;
+    std::int32_t threshold;
+    std::int32_t maxDepth;
+    std::int32_t accumulation;
+    // levels split by the worker among its own workers, then by theirs; 0 terminated
+    std::int32_t levels[maxLevelTiers - 1];
+};
+
+struct ResultHeader {
+    double computeSeconds;
+};
+
+struct MatrixHeader {
+    std::int32_t size;
+};
+
+inline void sendAll(int fd, const void* data, std::size_t count) {
+    auto bytes = static_cast<const char*>(data);
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+    while (count > 0) {
+        auto sent = send(fd, bytes, count, flags);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) throw std::runtime_error(std::string("Could not send data: ") + std::strerror(errno));
+        bytes += sent;
+        count -= sent;
+    }
+}
+
+// Returns false on a clean end of stream before the first byte.
+inline bool receiveAll(int fd, void* data, std::size_t count) {
+    auto bytes = static_cast<char*>(data);
+    auto requested = count;
+    while (count > 0) {
+        auto received = recv(fd, bytes, count, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0) throw std::runtime_error(std::string("Could not receive data: ") + std::strerror(errno));
+        if (received == 0) {
+            if (count == requested) return false;
+            throw std::runtime_error("Could not receive data: connection closed unexpectedly.");
+        }
+        bytes += received;
+        count -= received;
+    }
+    return true;
+}
+
+// Collects small writes (headers, rows) into large send() calls, so a message does not
+// go out as many small segments.
+class SendBuffer {
+public:
+    static constexpr std::size_t capacity = 64 * 1024;
+
+    explicit SendBuffer(int fd) : m_fd(fd) { m_buffer.reserve(capacity); }
+
+    void append(const void* data, std::size_t count) {
+        if (m_buffer.size() + count > capacity) flush();
+        if (count >= capacity) {
+            sendAll(m_fd, data, count);
+            return;
+        }
+        auto bytes = static_cast<const char*>(data);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + count);
+    }
+
+    void flush() {
+        if (!m_buffer.empty()) sendAll(m_fd, m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+    }
+
+private:
+    int m_fd;
+    std::vector<char> m_buffer;
+};
+
+template<typename T>
+std::uint64_t sendMatrix(SendBuffer& buffer, const Matrix<T>& matrix) {
+    MatrixHeader header{ matrix.size() };
+    buffer.append(&header, sizeof(header));
+    buffer.append(&matrix.padding(), sizeof(T));
+
+    // matrices may be views into bigger ones, so they are sent row by row
+    std::vector<T> row(matrix.size());
+    for (int i = 0; i < matrix.size(); i++) {
+        for (int j = 0; j < matrix.size(); j++) row[j] = matrix.get(i, j);
+        buffer.append(row.data(), row.size() * sizeof(T));
+    }
+    return sizeof(header) + sizeof(T) + std::uint64_t(matrix.size()) * matrix.size() * sizeof(T);
+}
+
+template<typename T>
+Matrix<T> receiveMatrix(int fd, std::uint64_t& bytesReceived) {
+    MatrixHeader header;
+    T padding;
+    if (!receiveAll(fd, &header, sizeof(header)) || !receiveAll(fd, &padding, sizeof(T))) {
+        throw std::runtime_error("Could not receive matrix: connection closed unexpectedly.");
+    }
+    // the element count must fit the int arithmetic of Matrix
+    if (header.size < 0 || std::int64_t(header.size) * header.size > std::numeric_limits<int>::max()) {
+        throw std::runtime_error("Could not receive matrix: incorrect size.");
+    }
+
+    Matrix<T> matrix(padding, header.size);
+    std::vector<T> row(header.size);
+    for (int i = 0; i < header.size; i++) {
+        if (!receiveAll(fd, row.data(), row.size() * sizeof(T))) {
+            throw std::runtime_error("Could not receive matrix: connection closed unexpectedly.");
+        }
+        for (int j = 0; j < header.size; j++) matrix.set(i, j, row[j]);
+    }
+    bytesReceived += sizeof(header) + sizeof(T) + std::uint64_t(header.size) * header.size * sizeof(T);
+    return matrix;
+}
+
+struct Address {
+    bool isUnix;
+    std::string host;
+    std::string port;
+    std::string path;
+};
+
+inline Address parseAddress(const std::string& address) {
+    Address result{};
+    if (address.rfind("unix:", 0) == 0) {
+        result.isUnix = true;
+        result.path = address.substr(5);
+        if (result.path.empty() || result.path.size() >= sizeof(sockaddr_un::sun_path)) {
+            throw std::runtime_error("Incorrect Unix socket path: " + address);
+        }
+        return result;
+    }
+
+    auto colonPos = address.rfind(':');
+    result.isUnix = false;
+    if (colonPos == std::string::npos) {
+        // a bare port means all interfaces when listening and localhost when connecting
+        result.port = address;
+    } else {
+        result.host = address.substr(0, colonPos);
+        result.port = address.substr(colonPos + 1);
+    }
+    if (result.port.empty()) throw std::runtime_error("Incorrect address: " + address);
+    return result;
+}
+
+inline int openSocket(const Address& address, bool listening) {
+    if (address.isUnix) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) throw std::runtime_error(std::string("Could not create socket: ") + std::strerror(errno));
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, address.path.c_str(), sizeof(addr.sun_path) - 1);
+        if (listening) unlink(address.path.c_str());
+
+        int status = listening ?
+            bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) :
+            connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        if (status < 0 || (listening && listen(fd, 16) < 0)) {
+            auto error = std::string(std::strerror(errno));
+            close(fd);
+            throw std::runtime_error("Could not " + std::string(listening ? "listen on " : "connect to ") + address.path + ": " + error);
+        }
+        return fd;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (listening) hints.ai_flags = AI_PASSIVE;
+
+    addrinfo* addresses = nullptr;
+    auto host = address.host.empty() ? nullptr : address.host.c_str();
+    if (int status = getaddrinfo(host, address.port.c_str(), &hints, &addresses); status != 0) {
+        throw std::runtime_error("Could not resolve " + address.host + ":" + address.port + ": " + gai_strerror(status));
+    }
+
+    int fd = -1;
+    for (auto info = addresses; info != nullptr; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) continue;
+
+        int enable = 1;
+        if (listening) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+            if (bind(fd, info->ai_addr, info->ai_addrlen) == 0 && listen(fd, 16) == 0) break;
+        } else {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            if (connect(fd, info->ai_addr, info->ai_addrlen) == 0) break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+
+    if (fd < 0) {
+        throw std::runtime_error("Could not " + std::string(listening ? "listen on " : "connect to ") + address.host + ":" + address.port);
+    }
+    return fd;
+}
+
+template<typename T, typename Acc = T>
+class Coordinator {
+public:
+    // levels[0] top levels are split into tasks here, the rest is passed on with the tasks
+    Coordinator(const std::vector<int>& workers, int threshold, const std::vector<int>& levels, int maxDepth) :
+        m_workers(workers), m_threshold(threshold), m_levels(levels), m_maxDepth(maxDepth), m_nextTask(0)
+    {
+        if (m_workers.empty()) throw std::runtime_error("No workers specified for distributed multiplication.");
+        if (m_levels.empty() || int(m_levels.size()) > maxLevelTiers) {
+            throw std::runtime_error("Incorrect number of distributed level tiers.");
+        }
+    }
+
+    Matrix<T> multiply(const Matrix<T>& lhs, const Matrix<T>& rhs) {
+        if (lhs.size() != rhs.size()) throw std::runtime_error("Could not multiply matrices: operand sizes do not match.");
+
+        m_stats = DistributedStats();
+        m_results.clear();
+        m_runningTasks.assign(m_workers.size(), -1);
+        m_workerComputeSeconds.assign(m_workers.size(), 0.0);
+        auto start = std::chrono::steady_clock::now();
+        distribute(lhs, rhs, m_levels.front(), m_maxDepth);
+        auto sent = std::chrono::steady_clock::now();
+        m_stats.sendSeconds = std::chrono::duration<double>(sent - start).count() - m_stats.receiveSeconds;
+        while (std::find_if(m_runningTasks.begin(), m_runningTasks.end(), [](int task) { return task >= 0; }) !=
+            m_runningTasks.end()) {
+            receiveResult();
+        }
+        m_stats.taskCount = int(m_results.size());
+
+        m_nextTask = 0;
+        auto result = gather(lhs.padding(), lhs.size(), m_levels.front(), m_maxDepth);
+        for (auto seconds : m_workerComputeSeconds) {
+            m_stats.workerComputeSeconds += seconds;
+            m_stats.maxWorkerComputeSeconds = std::max(m_stats.maxWorkerComputeSeconds, seconds);
+        }
+
+        return result;
+    }
+
+    const DistributedStats& stats() const { return m_stats; }
+
+private:
+    std::vector<int> m_workers;
+    int m_threshold;
+    std::vector<int> m_levels;
+    int m_maxDepth;
+    int m_nextTask;
+    DistributedStats m_stats;
+    // results in task order; task of each worker being computed (-1 when idle)
+    std::vector<Matrix<T>> m_results;
+    std::vector<int> m_runningTasks;
+    std::vector<double> m_workerComputeSeconds;
+
+    bool isLeaf(int size, int levels, int maxDepth) const {
+        return levels == 0 || size <= m_threshold || maxDepth == 0;
+    }
+
+    static int nextDepth(int maxDepth) {
+        return maxDepth < 0 ? maxDepth : maxDepth - 1;
+    }
+
+    // Waits for any running task to finish and stores its result. Returns the worker.
+    int receiveResult() {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<pollfd> fds;
+        std::vector<int> workers;
+        for (int worker = 0; worker < int(m_workers.size()); worker++) {
+            if (m_runningTasks[worker] < 0) continue;
+            fds.push_back({ m_workers[worker], POLLIN, 0 });
+            workers.push_back(worker);
+        }
+        while (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno != EINTR) throw std::runtime_error(std::string("Could not wait for results: ") + std::strerror(errno));
+        }
+
+        int i = 0;
+        while (fds[i].revents == 0) i++;
+        int worker = workers[i];
+        ResultHeader header;
+        if (!receiveAll(m_workers[worker], &header, sizeof(header))) {
+            throw std::runtime_error("Could not receive result: worker closed the connection.");
+        }
+        m_stats.bytesReceived += sizeof(header);
+        m_workerComputeSeconds[worker] += header.computeSeconds;
+        m_results[m_runningTasks[worker]] = receiveMatrix<T>(m_workers[worker], m_stats.bytesReceived);
+        m_runningTasks[worker] = -1;
+        m_stats.receiveSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return worker;
+    }
+
+    // Tasks are numbered in depth-first order and sent to the first idle worker while the
+    // operands are formed; gather() walks the same tree and takes the results in that order.
+    void distribute(const Matrix<T>& lhs, const Matrix<T>& rhs, int levels, int maxDepth) {
+        if (isLeaf(lhs.size(), levels, maxDepth)) {
+            auto idle = std::find(m_runningTasks.begin(), m_runningTasks.end(), -1);
+            int worker = idle != m_runningTasks.end() ? int(idle - m_runningTasks.begin()) : receiveResult();
+
+            TaskHeader header{ TaskTag, sizeof(T), m_threshold, maxDepth, accumulationOf<T, Acc>(), {} };
+            for (int i = 1; i < int(m_levels.size()); i++) header.levels[i - 1] = m_levels[i];
+            auto fd = m_workers[worker];
+            SendBuffer buffer(fd);
+            buffer.append(&header, sizeof(header));
+            m_stats.bytesSent += sizeof(header) + sendMatrix(buffer, lhs) + sendMatrix(buffer, rhs);
+            buffer.flush();
+            m_runningTasks[worker] = int(m_results.size());
+            m_results.emplace_back();
+            return;
+        }
+
+        ladermanProducts(lhs, rhs, [&](int, const Matrix<T>& lhsOperand, const Matrix<T>& rhsOperand) {
+            distribute(lhsOperand, rhsOperand, levels - 1, nextDepth(maxDepth));
+        });
+    }
+
+    Matrix<T> gather(T padding, int size, int levels, int maxDepth) {
+        if (isLeaf(size, levels, maxDepth)) return std::move(m_results[m_nextTask++]);
+
+        // products were distributed in the order the operand schedule forms them
+        constexpr auto order = laderman::productOrder(laderman::operandSchedule);
+        int partitionedSize = (size + 2) / 3;
+        std::vector<Matrix<T>> M(Matrix<T>::ladermanProductCount);
+        for (int index : order) {
+            M[index] = gather(padding, partitionedSize, levels - 1, nextDepth(maxDepth));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = ladermanAssemble<Acc>(M, padding, size);
+        m_stats.assembleSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+};
+
+template<typename T, typename Acc>
+Matrix<T> multiplyTask(const TaskHeader& header, const Matrix<T>& lhs, const Matrix<T>& rhs, const std::vector<int>* workers) {
+    if (header.levels[0] <= 0) return strassen3<Acc>(lhs, rhs, header.threshold, header.maxDepth);
+    if (workers == nullptr || workers->empty()) {
+        throw std::runtime_error("Could not multiply task: levels were placed on a worker without workers of its own.");
+    }
+
+    std::vector<int> levels;
+    for (int i = 0; i < maxLevelTiers - 1 && header.levels[i] > 0; i++) levels.push_back(header.levels[i]);
+    Coordinator<T, Acc> coordinator(*workers, header.threshold, levels, header.maxDepth);
+    return coordinator.multiply(lhs, rhs);
+}
+
+// Serves tasks on a connected socket until the coordinator closes it. Tasks with levels
+// placed on this worker are split among the given workers.
+template<typename T>
+void serveConnection(int fd, const std::vector<int>* workers = nullptr) {
+    std::uint64_t bytesReceived = 0;
+    for (;;) {
+        TaskHeader header;
+        if (!receiveAll(fd, &header, sizeof(header))) return;
+        if (header.tag != TaskTag) throw std::runtime_error("Could not receive task: unknown message.");
+        if (header.elementSize != sizeof(T)) {
+            throw std::runtime_error("Could not receive task: worker and coordinator use different precision.");
+        }
+        if (header.threshold < 1) throw std::runtime_error("Could not receive task: incorrect threshold.");
+
+        auto lhs = receiveMatrix<T>(fd, bytesReceived);
+        auto rhs = receiveMatrix<T>(fd, bytesReceived);
+
+        auto start = std::chrono::steady_clock::now();
+        Matrix<T> result;
+        switch (header.accumulation) {
+        case StorageAccumulation:
+            result = multiplyTask<T, T>(header, lhs, rhs, workers);
+            break;
+        case DoubleAccumulation:
+            result = multiplyTask<T, double>(header, lhs, rhs, workers);
+            break;
+        case KahanAccumulation:
+            result = multiplyTask<T, Kahan<T>>(header, lhs, rhs, workers);
+            break;
+        default:
+            throw std::runtime_error("Could not receive task: unknown accumulation type.");
+        }
+        ResultHeader resultHeader{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+        SendBuffer buffer(fd);
+        buffer.append(&resultHeader, sizeof(resultHeader));
+        sendMatrix(buffer, result);
+        buffer.flush();
+    }
+}
+
+// Connections to remote workers given by addresses and to localWorkers forked processes
+// connected through Unix socket pairs. Forked processes close inheritedFds.
+template<typename T>
+class WorkerPool {
+public:
+    WorkerPool(const std::vector<std::string>& addresses, int localWorkers, const std::vector<int>& inheritedFds = {}) {
+        try {
+            for (const auto& address : addresses) {
+                m_workers.push_back(openSocket(parseAddress(address), false));
+            }
+
+            for (int i = 0; i < localWorkers; i++) {
+                int fds[2];
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+                    throw std::runtime_error(std::string("Could not create socket pair: ") + std::strerror(errno));
+                }
+
+                pid_t pid = fork();
+                if (pid < 0) {
+                    close(fds[0]);
+                    close(fds[1]);
+                    throw std::runtime_error(std::string("Could not start worker process: ") + std::strerror(errno));
+                }
+                if (pid == 0) {
+                    close(fds[0]);
+                    for (auto fd : m_workers) close(fd);
+                    for (auto fd : inheritedFds) close(fd);
+                    int status = EXIT_SUCCESS;
+                    try {
+                        serveConnection<T>(fds[1]);
+                    }
+                    catch (const std::exception& error) {
+                        std::cerr << error.what() << std::endl;
+                        status = EXIT_FAILURE;
+                    }
+                    _exit(status);
+                }
+                close(fds[1]);
+                m_workers.push_back(fds[0]);
+                m_children.push_back(pid);
+            }
+        }
+        catch (...) {
+            closeAll();
+            throw;
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() { closeAll(); }
+
+    const std::vector<int>& workers() const { return m_workers; }
+
+private:
+    std::vector<int> m_workers;
+    std::vector<pid_t> m_children;
+
+    // closed connections end the worker processes
+    void closeAll() {
+        for (auto fd : m_workers) close(fd);
+        for (auto pid : m_children) waitpid(pid, nullptr, 0);
+        m_workers.clear();
+        m_children.clear();
+    }
+};
+
+} // namespace distributed
+
+// Accepts coordinator connections on the given address and serves them one at a time.
+// Levels placed on this worker are split among the remote workers given by addresses
+// and localWorkers forked processes, connected anew for each coordinator.
+template<typename T>
+void runWorker(const std::string& address, const std::vector<std::string>& addresses = {}, int localWorkers = 0) {
+    auto parsed = distributed::parseAddress(address);
+    int listenFd = distributed::openSocket(parsed, true);
+    for (;;) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            close(listenFd);
+            throw std::runtime_error(std::string("Could not accept connection: ") + std::strerror(errno));
+        }
+        if (!parsed.isUnix) {
+            // results are written in a single burst, do not hold back its last segment
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+        try {
+            std::optional<distributed::WorkerPool<T>> pool;
+            if (!addresses.empty() || localWorkers > 0) pool.emplace(addresses, localWorkers, std::vector<int>{ listenFd, fd });
+            distributed::serveConnection<T>(fd, pool ? &pool->workers() : nullptr);
+        }
+        catch (const std::exception& error) {
+            std::cerr << error.what() << std::endl;
+        }
+        close(fd);
+    }
+}
+
+// Multiplies on remote workers given by addresses and on localWorkers forked processes
+// connected through Unix socket pairs. Threshold, maxDepth and Acc mean the same as for strassen3().
+// levels[0] top levels are split among these workers, the following entries are split by the
+// workers among their own workers (see runWorker()).
+template<typename T, typename Acc = T>
+Matrix<T> distributedStrassen3(const Matrix<T>& lhs, const Matrix<T>& rhs, int threshold, int maxDepth,
+    const std::vector<int>& levels, const std::vector<std::string>& addresses, int localWorkers, DistributedStats& stats)
+{
+    distributed::WorkerPool<T> pool(addresses, localWorkers);
+    distributed::Coordinator<T, Acc> coordinator(pool.workers(), threshold, levels, maxDepth);
+    auto result = coordinator.multiply(lhs, rhs);
+    stats = coordinator.stats();
+    return result;
+}
+
+#else
+
+template<typename T>
+void runWorker(const std::string&, const std::vector<std::string>& = {}, int = 0) {
+    throw std::runtime_error("Distributed mode is not supported on this platform.");
+}
+
+template<typename T, typename Acc = T>
+Matrix<T> distributedStrassen3(const Matrix<T>&, const Matrix<T>&, int, int,
+    const std::vector<int>&, const std::vector<std::string>&, int, DistributedStats&)
+{
+    throw std::runtime_error("Distributed mode is not supported on this platform.");
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+// Compensated (Kahan-Babuska / Neumaier) summation in the precision of T.
+template<class T>
+class Kahan {
+public:
+	Kahan(T value = 0) : m_sum(value), m_compensation(0) { }
+
+	Kahan<T>& operator+=(const T& value) {
+		T sum = m_sum + value;
+		if (std::abs(m_sum) >= std::abs(value)) m_compensation += (m_sum - sum) + value;
+		else m_compensation += (value - sum) + m_sum;
+		m_sum = sum;
+		return *this;
+	}
+
+	operator T() const {
+		return m_sum + m_compensation;
+	}
+
+private:
+	T m_sum;
+	T m_compensation;
+};
+
+// Estimated relative rounding error of a dot product of length n accumulated in Acc,
+// assuming rounding errors are independent (grow as sqrt(n) instead of n).
+template<class Acc>
+struct AccumulationError {
+	static double dotProduct(int n) {
+		return std::sqrt(double(n)) * std::numeric_limits<Acc>::epsilon() / 2;
+	}
+};
+
+// compensated summation error does not grow with n (to first order)
+template<class T>
+struct AccumulationError<Kahan<T>> {
+	static double dotProduct(int) {
+		return std::numeric_limits<T>::epsilon();
+	}
+};
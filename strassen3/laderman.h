@@ -0,0 +1,422 @@
+#pragma once
+
+#include <array>
+#include <span>
+
+// Laderman's 3x3 algorithm (23 products) described as data: coefficients of the product
+// operands and of the C_ij sums, plus addition schedules that evaluate them.
+namespace laderman {
+
+constexpr int productCount = 23;
+constexpr int blockCount = 9;
+
+enum Register {
+	A11, A12, A13, A21, A22, A23, A31, A32, A33,
+	B11, B12, B13, B21, B22, B23, B31, B32, B33,
+	M1, M2, M3, M4, M5, M6, M7, M8, M9, M10, M11, M12,
+	M13, M14, M15, M16, M17, M18, M19, M20, M21, M22, M23,
+	C11, C12, C13, C21, C22, C23, C31, C32, C33,
+	T1, T2, T3, T4, T5, T6, T7, T8,
+	RegisterCount
+};
+
+enum class Op {
+	Add,      // target = lhs + rhs
+	Subtract, // target = lhs - rhs
+	Multiply  // target (M_i) = lhs * rhs
+};
+
+struct Step {
+	Op op;
+	Register target;
+	Register lhs;
+	Register rhs;
+};
+
+// A side operand of M_i over blocks A11, A12, A13, A21, A22, A23, A31, A32, A33.
+constexpr int lhsCoefficients[productCount][blockCount] = {
+	{ 1, 1, 1, -1, -1, 0, 0, -1, -1 },
+	{ 1, 0, 0, -1, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 1, 0, 0, 0, 0 },
+	{ -1, 0, 0, 1, 1, 0, 0, 0, 0 },
+	{ 0, 0, 0, 1, 1, 0, 0, 0, 0 },
+	{ 1, 0, 0, 0, 0, 0, 0, 0, 0 },
+	{ -1, 0, 0, 0, 0, 0, 1, 1, 0 },
+	{ -1, 0, 0, 0, 0, 0, 1, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, 1, 1, 0 },
+	{ 1, 1, 1, 0, -1, -1, -1, -1, 0 },
+	{ 0, 0, 0, 0, 0, 0, 0, 1, 0 },
+	{ 0, 0, -1, 0, 0, 0, 0, 1, 1 },
+	{ 0, 0, 1, 0, 0, 0, 0, 0, -1 },
+	{ 0, 0, 1, 0, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, 0, 1, 1 },
+	{ 0, 0, -1, 0, 1, 1, 0, 0, 0 },
+	{ 0, 0, 1, 0, 0, -1, 0, 0, 0 },
+	{ 0, 0, 0, 0, 1, 1, 0, 0, 0 },
+	{ 0, 1, 0, 0, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 0, 1, 0, 0, 0 },
+	{ 0, 0, 0, 1, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, 1, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1 }
+};
+
+// B side operand of M_i over blocks B11, B12, B13, B21, B22, B23, B31, B32, B33.
+constexpr int rhsCoefficients[productCount][blockCount] = {
+	{ 0, 0, 0, 0, 1, 0, 0, 0, 0 },
+	{ 0, -1, 0, 0, 1, 0, 0, 0, 0 },
+	{ -1, 1, 0, 1, -1, -1, -1, 0, 1 },
+	{ 1, -1, 0, 0, 1, 0, 0, 0, 0 },
+	{ -1, 1, 0, 0, 0, 0, 0, 0, 0 },
+	{ 1, 0, 0, 0, 0, 0, 0, 0, 0 },
+	{ 1, 0, -1, 0, 0, 1, 0, 0, 0 },
+	{ 0, 0, 1, 0, 0, -1, 0, 0, 0 },
+	{ -1, 0, 1, 0, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 0, 1, 0, 0, 0 },
+	{ -1, 0, 1, 1, -1, -1, -1, 1, 0 },
+	{ 0, 0, 0, 0, 1, 0, 1, -1, 0 },
+	{ 0, 0, 0, 0, 1, 0, 0, -1, 0 },
+	{ 0, 0, 0, 0, 0, 0, 1, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, -1, 1, 0 },
+	{ 0, 0, 0, 0, 0, 1, 1, 0, -1 },
+	{ 0, 0, 0, 0, 0, 1, 0, 0, -1 },
+	{ 0, 0, 0, 0, 0, 0, -1, 0, 1 },
+	{ 0, 0, 0, 1, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, 0, 1, 0 },
+	{ 0, 0, 1, 0, 0, 0, 0, 0, 0 },
+	{ 0, 1, 0, 0, 0, 0, 0, 0, 0 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1 }
+};
+
+// Most products summed into a single C_ij.
+constexpr int maxTerms = 7;
+
+struct Sum {
+	int count;
+	Register terms[maxTerms];
+};
+
+// C11, C12, ..., C33 as sums of products.
+constexpr Sum resultSums[blockCount] = {
+	{ 3, { M6, M14, M19 } },
+	{ 7, { M1, M4, M5, M6, M12, M14, M15 } },
+	{ 7, { M6, M7, M9, M10, M14, M16, M18 } },
+	{ 7, { M2, M3, M4, M6, M14, M16, M17 } },
+	{ 5, { M2, M4, M5, M6, M20 } },
+	{ 5, { M14, M16, M17, M18, M21 } },
+	{ 7, { M6, M7, M8, M11, M12, M13, M14 } },
+	{ 5, { M12, M13, M14, M15, M22 } },
+	{ 5, { M6, M7, M8, M9, M23 } }
+};
+
+// Operand schedule sharing partial sums between products: A21+A22 gives M5 and M4,
+// A31+A32 gives M9 and M7, B22-B12 gives M2 and M4, B21-B22-B23 is shared by M3 and M11 etc.
+// Products are grouped so that at most 8 temporaries are alive at once.
+constexpr Step operandSchedule[] = {
+	{ Op::Add, T1, A21, A22 },
+	{ Op::Subtract, T2, B12, B11 },
+	{ Op::Multiply, M5, T1, T2 },
+	{ Op::Subtract, T3, T1, A11 },
+	{ Op::Subtract, T4, B22, B12 },
+	{ Op::Subtract, T5, A11, A21 },
+	{ Op::Multiply, M2, T5, T4 },
+	{ Op::Add, T4, T4, B11 },
+	{ Op::Multiply, M4, T3, T4 },
+
+	{ Op::Subtract, T3, A13, A33 },
+	{ Op::Subtract, T4, B22, B32 },
+	{ Op::Multiply, M13, T3, T4 },
+	{ Op::Subtract, T3, A32, T3 },
+	{ Op::Add, T4, T4, B31 },
+	{ Op::Multiply, M12, T3, T4 },
+	{ Op::Add, T4, A32, A33 },
+	{ Op::Subtract, T5, B32, B31 },
+	{ Op::Multiply, M15, T4, T5 },
+
+	{ Op::Add, T4, A11, A12 },
+	{ Op::Subtract, T1, T4, T1 },
+	{ Op::Subtract, T1, T1, T3 },
+	{ Op::Multiply, M1, T1, B22 },
+
+	{ Op::Add, T1, A31, A32 },
+	{ Op::Subtract, T3, B13, B11 },
+	{ Op::Multiply, M9, T1, T3 },
+	{ Op::Subtract, T6, T1, A11 },
+	{ Op::Subtract, T7, B13, B23 },
+	{ Op::Subtract, T8, A31, A11 },
+	{ Op::Multiply, M8, T8, T7 },
+	{ Op::Subtract, T7, B11, T7 },
+	{ Op::Multiply, M7, T6, T7 },
+
+	{ Op::Subtract, T6, B21, B22 },
+	{ Op::Subtract, T6, T6, B23 },
+	{ Op::Add, T3, T6, T3 },
+	{ Op::Add, T3, T3, T5 },
+	{ Op::Multiply, M11, A32, T3 },
+
+	{ Op::Subtract, T3, A13, A23 },
+	{ Op::Subtract, T5, B23, B33 },
+	{ Op::Multiply, M17, T3, T5 },
+	{ Op::Subtract, T3, A22, T3 },
+	{ Op::Add, T5, T5, B31 },
+	{ Op::Multiply, M16, T3, T5 },
+	{ Op::Add, T5, A22, A23 },
+	{ Op::Subtract, T7, B33, B31 },
+	{ Op::Multiply, M18, T5, T7 },
+
+	{ Op::Subtract, T4, T4, T1 },
+	{ Op::Subtract, T4, T4, T3 },
+	{ Op::Multiply, M10, T4, B23 },
+	{ Op::Add, T2, T6, T2 },
+	{ Op::Add, T2, T2, T7 },
+	{ Op::Multiply, M3, A22, T2 },
+
+	{ Op::Multiply, M6, A11, B11 },
+	{ Op::Multiply, M14, A13, B31 },
+	{ Op::Multiply, M19, A12, B21 },
+	{ Op::Multiply, M20, A23, B32 },
+	{ Op::Multiply, M21, A21, B13 },
+	{ Op::Multiply, M22, A31, B12 },
+	{ Op::Multiply, M23, A33, B33 }
+};
+
+// Assembly schedule sharing partial sums between C_ij: M4+M6 feeds C12 and (with M2) C21
+// and C22, M14+M16 feeds C13, C21 and C23 etc. Partial sums are kept in C blocks where
+// possible; blocks of the last row or column may be clipped, so they only feed blocks that
+// are clipped the same way.
+constexpr Step assemblySchedule[] = {
+	{ Op::Add, C12, M4, M6 },
+	{ Op::Add, C22, C12, M2 },
+	{ Op::Add, C11, M14, M16 },
+	{ Op::Add, T1, C11, M17 },
+	{ Op::Add, C21, C22, T1 },
+	{ Op::Add, C21, C21, M3 },
+	{ Op::Add, C22, C22, M5 },
+	{ Op::Add, C22, C22, M20 },
+	{ Op::Add, C23, T1, M18 },
+	{ Op::Add, C23, C23, M21 },
+
+	{ Op::Add, T1, M6, M7 },
+	{ Op::Add, C13, T1, M9 },
+	{ Op::Add, C33, C13, M8 },
+	{ Op::Add, C33, C33, M23 },
+	{ Op::Add, C13, C13, C11 },
+	{ Op::Add, C13, C13, M18 },
+	{ Op::Add, C13, C13, M10 },
+
+	{ Op::Add, C11, M12, M14 },
+	{ Op::Add, C31, C11, T1 },
+	{ Op::Add, C31, C31, M8 },
+	{ Op::Add, C31, C31, M11 },
+	{ Op::Add, C31, C31, M13 },
+	{ Op::Add, C11, C11, M15 },
+	{ Op::Add, C12, C12, C11 },
+	{ Op::Add, C12, C12, M1 },
+	{ Op::Add, C12, C12, M5 },
+	{ Op::Add, C32, C11, M13 },
+	{ Op::Add, C32, C32, M22 },
+
+	{ Op::Add, C11, M6, M14 },
+	{ Op::Add, C11, C11, M19 }
+};
+
+// Max over C_ij of the sum, over products M_i in C_ij, of the number of A terms times the
+// number of B terms of M_i.
+constexpr int errorGrowth() {
+	int growth = 0;
+	for (const auto& sum : resultSums) {
+		int blockGrowth = 0;
+		for (int term = 0; term < sum.count; term++) {
+			int product = sum.terms[term] - M1, lhsTerms = 0, rhsTerms = 0;
+			for (int block = 0; block < blockCount; block++) {
+				lhsTerms += lhsCoefficients[product][block] != 0;
+				rhsTerms += rhsCoefficients[product][block] != 0;
+			}
+			blockGrowth += lhsTerms * rhsTerms;
+		}
+		if (blockGrowth > growth) growth = blockGrowth;
+	}
+	return growth;
+}
+
+constexpr bool isTemporary(Register reg) {
+	return reg >= T1 && reg < RegisterCount;
+}
+
+constexpr bool isResult(Register reg) {
+	return reg >= C11 && reg <= C33;
+}
+
+// Number of O(n^2) addition passes of a schedule.
+constexpr int additionPasses(std::span<const Step> schedule) {
+	int passes = 0;
+	for (const auto& step : schedule) {
+		if (step.op != Op::Multiply) passes++;
+	}
+	return passes;
+}
+
+constexpr int temporaryCount(std::span<const Step> schedule) {
+	int count = 0;
+	for (const auto& step : schedule) {
+		if (isTemporary(step.target) && step.target - T1 + 1 > count) count = step.target - T1 + 1;
+	}
+	return count;
+}
+
+// Product indices (0 for M1) in the order the schedule multiplies them.
+constexpr std::array<int, productCount> productOrder(std::span<const Step> schedule) {
+	std::array<int, productCount> order{};
+	int count = 0;
+	for (const auto& step : schedule) {
+		if (step.op == Op::Multiply && count < productCount) order[count++] = step.target - M1;
+	}
+	return order;
+}
+
+// Checks symbolically that an operand schedule forms each product operand exactly once
+// and writes only to temporaries.
+constexpr bool isValidOperandSchedule(std::span<const Step> schedule) {
+	// coefficients over A11..A33 followed by B11..B33
+	int values[RegisterCount][2 * blockCount] = {};
+	bool defined[RegisterCount] = {};
+	bool multiplied[productCount] = {};
+	for (int block = 0; block < 2 * blockCount; block++) {
+		values[block][block] = 1;
+		defined[block] = true;
+	}
+
+	for (const auto& step : schedule) {
+		if (!defined[step.lhs] || !defined[step.rhs]) return false;
+		if (step.op == Op::Multiply) {
+			if (step.target < M1 || step.target > M23 || multiplied[step.target - M1]) return false;
+			int product = step.target - M1;
+			for (int block = 0; block < blockCount; block++) {
+				if (values[step.lhs][block] != lhsCoefficients[product][block]) return false;
+				if (values[step.lhs][blockCount + block] != 0) return false;
+				if (values[step.rhs][block] != 0) return false;
+				if (values[step.rhs][blockCount + block] != rhsCoefficients[product][block]) return false;
+			}
+			multiplied[product] = true;
+			continue;
+		}
+
+		if (!isTemporary(step.target)) return false;
+		int sign = step.op == Op::Add ? 1 : -1;
+		for (int block = 0; block < 2 * blockCount; block++) {
+			values[step.target][block] = values[step.lhs][block] + sign * values[step.rhs][block];
+		}
+		defined[step.target] = true;
+	}
+
+	for (bool isMultiplied : multiplied) {
+		if (!isMultiplied) return false;
+	}
+	return true;
+}
+
+// Checks symbolically that an assembly schedule computes every C_ij, writes only to C blocks
+// and temporaries, and never reads a clipped C block into a block it does not cover.
+constexpr bool isValidAssemblySchedule(std::span<const Step> schedule) {
+	int values[RegisterCount][productCount] = {};
+	bool defined[RegisterCount] = {};
+	for (int product = 0; product < productCount; product++) {
+		values[M1 + product][product] = 1;
+		defined[M1 + product] = true;
+	}
+
+	auto covers = [](Register source, Register target) {
+		if (!isResult(source)) return true;
+		int sourceRow = (source - C11) / 3, sourceCol = (source - C11) % 3;
+		int targetRow = isResult(target) ? (target - C11) / 3 : 0;
+		int targetCol = isResult(target) ? (target - C11) % 3 : 0;
+		return (sourceRow < 2 || targetRow == 2) && (sourceCol < 2 || targetCol == 2);
+	};
+
+	for (const auto& step : schedule) {
+		if (step.op != Op::Add && step.op != Op::Subtract) return false;
+		if (!isResult(step.target) && !isTemporary(step.target)) return false;
+		if (!defined[step.lhs] || !defined[step.rhs]) return false;
+		if (!covers(step.lhs, step.target) || !covers(step.rhs, step.target)) return false;
+
+		int sign = step.op == Op::Add ? 1 : -1;
+		for (int product = 0; product < productCount; product++) {
+			values[step.target][product] = values[step.lhs][product] + sign * values[step.rhs][product];
+		}
+		defined[step.target] = true;
+	}
+
+	for (int block = 0; block < blockCount; block++) {
+		int expected[productCount] = {};
+		for (int term = 0; term < resultSums[block].count; term++) expected[resultSums[block].terms[term] - M1] = 1;
+		for (int product = 0; product < productCount; product++) {
+			if (values[C11 + block][product] != expected[product]) return false;
+		}
+	}
+	return true;
+}
+
+constexpr int naiveOperandStepCount() {
+	int count = productCount;
+	for (int product = 0; product < productCount; product++) {
+		int lhsTerms = 0, rhsTerms = 0;
+		for (int block = 0; block < blockCount; block++) {
+			lhsTerms += lhsCoefficients[product][block] != 0;
+			rhsTerms += rhsCoefficients[product][block] != 0;
+		}
+		count += lhsTerms - 1 + rhsTerms - 1;
+	}
+	return count;
+}
+
+// Forms each operand from scratch, left to right, into T1 (A side) or T2 (B side).
+// Every operand has at least one positive term, which is taken first.
+constexpr std::array<Step, naiveOperandStepCount()> naiveOperandSchedule() {
+	std::array<Step, naiveOperandStepCount()> schedule{};
+	int count = 0;
+	auto form = [&](const int* coefficients, Register firstBlock, Register temporary) {
+		int first = 0;
+		while (coefficients[first] <= 0) first++;
+		Register operand = Register(firstBlock + first);
+		for (int block = 0; block < blockCount; block++) {
+			if (block == first || coefficients[block] == 0) continue;
+			schedule[count++] = { coefficients[block] > 0 ? Op::Add : Op::Subtract, temporary, operand, Register(firstBlock + block) };
+			operand = temporary;
+		}
+		return operand;
+	};
+
+	for (int product = 0; product < productCount; product++) {
+		auto lhs = form(lhsCoefficients[product], A11, T1);
+		auto rhs = form(rhsCoefficients[product], B11, T2);
+		schedule[count++] = { Op::Multiply, Register(M1 + product), lhs, rhs };
+	}
+	return schedule;
+}
+
+constexpr int naiveAssemblyStepCount() {
+	int count = 0;
+	for (const auto& sum : resultSums) count += sum.count - 1;
+	return count;
+}
+
+// Sums each C_ij from scratch, left to right, in place.
+constexpr std::array<Step, naiveAssemblyStepCount()> naiveAssemblySchedule() {
+	std::array<Step, naiveAssemblyStepCount()> schedule{};
+	int count = 0;
+	for (int block = 0; block < blockCount; block++) {
+		Register target = Register(C11 + block);
+		Register operand = resultSums[block].terms[0];
+		for (int term = 1; term < resultSums[block].count; term++) {
+			schedule[count++] = { Op::Add, target, operand, resultSums[block].terms[term] };
+			operand = target;
+		}
+	}
+	return schedule;
+}
+
+static_assert(isValidOperandSchedule(operandSchedule));
+static_assert(isValidAssemblySchedule(assemblySchedule));
+static_assert(isValidOperandSchedule(naiveOperandSchedule()));
+static_assert(isValidAssemblySchedule(naiveAssemblySchedule()));
+
+} // namespace laderman
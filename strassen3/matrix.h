@@ -3,9 +3,16 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <span>
 #include <vector>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include "accumulator.h"
+#include "laderman.h"
 
 template<class T>
 class Matrix {
@@ -16,6 +23,11 @@ public:
         *this = matrix;
 	}
 
+	Matrix(Matrix<T>&& matrix) : m_isDataOwner(false)
+	{
+		*this = std::move(matrix);
+	}
+
 	Matrix(T padding = 0, int size = 0) : m_padding(padding), m_isDataOwner(false), m_dataSize(0)
 	{
 		resize(size);
@@ -79,6 +91,10 @@ public:
 		if (m_dataSize < m_size) reserve(m_size);
 	}
 
+	int size() const { return m_size; }
+
+	const T& padding() const { return m_padding; }
+
 	inline T& operator()(int row, int col) {
 		return m_data[row * m_dataSize + col];
 	}
@@ -147,6 +163,7 @@ public:
 	}
 
 	friend Matrix<T> operator+(Matrix<T> lhs, const Matrix<T>& rhs) {
+		lhs.materialize();
 		lhs += rhs;
 		return lhs;
 	}
@@ -176,6 +193,7 @@ public:
 	}
 
 	friend Matrix<T> operator-(Matrix<T> lhs, const Matrix<T>& rhs) {
+		lhs.materialize();
 		lhs -= rhs;
 		return lhs;
 	}
@@ -192,11 +210,13 @@ public:
 	}
 
 	friend Matrix<T> operator*(Matrix<T> lhs, const T& scalar) {
+		lhs.materialize();
 		lhs *= scalar;
 		return lhs;
 	}
 
 	friend Matrix<T> operator*(const T& scalar, Matrix<T> rhs) {
+		rhs.materialize();
 		rhs *= scalar;
 		return rhs;
 	}
@@ -207,21 +227,32 @@ public:
 	}
 
 	friend Matrix<T> operator*(const Matrix<T>& lhs, const Matrix<T>& rhs) {
+		return multiplyTrivial(lhs, rhs);
+	}
+
+	// Trivial multiplication with dot products accumulated in Acc (e.g. double or Kahan<T>)
+	// and rounded to T once per element.
+	template<typename Acc = T>
+	friend Matrix<T> multiplyTrivial(const Matrix<T>& lhs, const Matrix<T>& rhs) {
 		if (lhs.m_size != rhs.m_size) throw std::runtime_error("Could not multiply matrices: operand sizes do not match.");
 		Matrix<T> result(lhs.m_padding, lhs.m_size);
 		for (int i = 0; i < lhs.m_size; i++) {
 			for (int j = 0; j < lhs.m_size; j++) {
-				T sum = 0;
+				Acc sum = Acc();
 				for (int k = 0; k < lhs.m_size; k++) {
-					sum += lhs.get(i, k) * rhs.get(k, j);
+					if constexpr (std::is_arithmetic_v<Acc>) sum += Acc(lhs.get(i, k)) * Acc(rhs.get(k, j));
+					else sum += lhs.get(i, k) * rhs.get(k, j);
 				}
-				result.set(i, j, sum);
+				result.set(i, j, static_cast<T>(sum));
 			}
 		}
 		return result;
 	}
 
-	friend Matrix<T> strassen3(const Matrix<T>& lhs, const Matrix<T>& rhs, int threshold = 1) {
+	// Strassen3 multiplication with leaf dot products and C_ij assembly accumulated in Acc.
+	// Below maxDepth levels of recursion (unlimited if negative) the trivial algorithm is used.
+	template<typename Acc = T>
+	friend Matrix<T> strassen3(const Matrix<T>& lhs, const Matrix<T>& rhs, int threshold = 1, int maxDepth = -1) {
 		if (lhs.m_size != rhs.m_size) throw std::runtime_error("Could not multiply matrices: operand sizes do not match.");
 
         if (lhs.m_rowsStart >= lhs.m_rowsEnd || lhs.m_colsStart >= lhs.m_colsEnd ||
@@ -230,71 +261,141 @@ public:
         }
 
 		// when matrices degenerated to scalar (m_size = 1) just "normal" multiplication
-		if (lhs.m_size <= threshold) return lhs * rhs;
+		if (lhs.m_size <= threshold || maxDepth == 0) return multiplyTrivial<Acc>(lhs, rhs);
+
+		// calculate M_i submatrices (23 multiplications)
+		std::vector<Matrix<T>> M(ladermanProductCount);
+		ladermanProducts(lhs, rhs, [&](int index, const Matrix<T>& lhsOperand, const Matrix<T>& rhsOperand) {
+			M[index] = strassen3<Acc>(lhsOperand, rhsOperand, threshold, maxDepth < 0 ? maxDepth : maxDepth - 1);
+		});
+
+		return ladermanAssemble<Acc>(M, lhs.m_padding, lhs.m_size);
+	}
+
+	// Bounds error amplification per level (35 for Laderman's algorithm).
+	static constexpr int ladermanErrorGrowth = laderman::errorGrowth();
+
+	// Heuristic relative error estimate of strassen3<Acc>() with depth levels of recursion.
+	// Rounding errors are assumed independent, so they add up in root-mean-square fashion.
+	// Every level and the leaf products round their results to T, even if Acc is wider.
+	template<typename Acc = T>
+	static double strassen3ErrorEstimate(int size, int depth) {
+		int leafSize = size;
+		for (int level = 0; level < depth; level++) leafSize = (leafSize + 2) / 3;
+		auto growth = std::sqrt(std::pow(double(ladermanErrorGrowth), depth));
+		auto storageError = std::numeric_limits<T>::epsilon() / 2;
+		return growth * ((depth + 1) * storageError + AccumulationError<Acc>::dotProduct(std::max(leafSize, 1)));
+	}
+
+	// The deepest recursion (at most the depth reached with the given threshold) whose
+	// estimated relative error does not exceed the tolerance.
+	template<typename Acc = T>
+	static int strassen3MaxDepth(int size, int threshold, double tolerance) {
+		int depth = 0;
+		for (int leafSize = size; leafSize > threshold; leafSize = (leafSize + 2) / 3) {
+			if (strassen3ErrorEstimate<Acc>(size, depth + 1) > tolerance) break;
+			depth++;
+		}
+		return depth;
+	}
+
+	static constexpr int ladermanProductCount = laderman::productCount;
+
+	// Forms operands of the 23 products of a single Laderman step following the schedule and
+	// passes each pair to product(index, lhsOperand, rhsOperand), where index is 0 for M1.
+	// Operands may live in reused buffers, so they are valid only for the duration of the call.
+	template<typename Product>
+	friend void ladermanProducts(const Matrix<T>& lhs, const Matrix<T>& rhs, Product&& product,
+		std::span<const laderman::Step> schedule = laderman::operandSchedule)
+	{
+		if (lhs.m_size != rhs.m_size) throw std::runtime_error("Could not multiply matrices: operand sizes do not match.");
 
 		// divide matrices to 9 (3x3) submatrices
 		auto A = lhs.partition(3);
-		const auto& A11 = A(0, 0);
-		const auto& A12 = A(0, 1);
-		const auto& A13 = A(0, 2);
-		const auto& A21 = A(1, 0);
-		const auto& A22 = A(1, 1);
-		const auto& A23 = A(1, 2);
-		const auto& A31 = A(2, 0);
-		const auto& A32 = A(2, 1);
-		const auto& A33 = A(2, 2);
-
 		auto B = rhs.partition(3);
-		const auto& B11 = B(0, 0);
-		const auto& B12 = B(0, 1);
-		const auto& B13 = B(0, 2);
-		const auto& B21 = B(1, 0);
-		const auto& B22 = B(1, 1);
-		const auto& B23 = B(1, 2);
-		const auto& B31 = B(2, 0);
-		const auto& B32 = B(2, 1);
-		const auto& B33 = B(2, 2);
 
-		// calculate M_i submatrices (23 multiplications)
-		Matrix<T> buf(A11.m_padding, A11.m_size);
-		Matrix<T> buf2(B11.m_padding, B11.m_size);
-		auto M1 = strassen3(buf.acc(A11, A12, A13).sub(A21, A22, A32, A33), B22, threshold);
-		auto M2 = strassen3(buf.acc(A11).sub(A21), buf2.acc(B22).sub(B12), threshold);
-		auto M3 = strassen3(A22, buf2.acc(B12, B21, B33).sub(B11, B22, B23, B31), threshold);
-		auto M4 = strassen3(buf.acc(A21, A22).sub(A11), buf2.acc(B11, B22).sub(B12), threshold);
-		auto M5 = strassen3(buf.acc(A21, A22), buf2.acc(B12).sub(B11), threshold);
-		auto M6 = strassen3(A11, B11, threshold);
-		auto M7 = strassen3(buf.acc(A31, A32).sub(A11), buf2.acc(B11, B23).sub(B13), threshold);
-		auto M8 = strassen3(buf.acc(A31).sub(A11), buf2.acc(B13).sub(B23), threshold);
-		auto M9 = strassen3(buf.acc(A31, A32), buf2.acc(B13).sub(B11), threshold);
-		auto M10 = strassen3(buf.acc(A11, A12, A13).sub(A22, A23, A31, A32), B23, threshold);
-		auto M11 = strassen3(A32, buf2.acc(B13, B21, B32).sub(B11, B22, B23, B31), threshold);
-		auto M12 = strassen3(buf.acc(A32, A33).sub(A13), buf2.acc(B22, B31).sub(B32), threshold);
-		auto M13 = strassen3(buf.acc(A13).sub(A33), buf2.acc(B22).sub(B32), threshold);
-		auto M14 = strassen3(A13, B31, threshold);
-		auto M15 = strassen3(buf.acc(A32, A33), buf2.acc(B32).sub(B31), threshold);
-		auto M16 = strassen3(buf.acc(A22, A23).sub(A13), buf2.acc(B23, B31).sub(B33), threshold);
-		auto M17 = strassen3(buf.acc(A13).sub(A23), buf2.acc(B23).sub(B33), threshold);
-		auto M18 = strassen3(buf.acc(A22, A23), buf2.acc(B33).sub(B31), threshold);
-		auto M19 = strassen3(A12, B21, threshold);
-		auto M20 = strassen3(A23, B32, threshold);
-		auto M21 = strassen3(A21, B13, threshold);
-		auto M22 = strassen3(A31, B12, threshold);
-		auto M23 = strassen3(A33, B33, threshold);
+		std::unique_ptr<T[]> storage;
+		auto temporaries = makeTemporaries(storage, laderman::temporaryCount(schedule), A(0, 0).m_padding, A(0, 0).m_size);
 
-		// calculated C_ij submatrices
-		Matrix<T> result(lhs.m_padding, lhs.m_size);
+		// registers that may be read; temporaries become readable once written
+		const Matrix<T>* registers[laderman::RegisterCount] = {};
+		for (int block = 0; block < laderman::blockCount; block++) {
+			registers[laderman::A11 + block] = &A(block / 3, block % 3);
+			registers[laderman::B11 + block] = &B(block / 3, block % 3);
+		}
+		auto source = [&](laderman::Register reg) -> const Matrix<T>& {
+			if (reg < 0 || reg >= laderman::RegisterCount || registers[reg] == nullptr) {
+				throw std::runtime_error("Could not form operands: incorrect schedule.");
+			}
+			return *registers[reg];
+		};
+
+		// form operands of M_i submatrices (23 multiplications)
+		for (const auto& step : schedule) {
+			if (step.op == laderman::Op::Multiply) {
+				if (step.target < laderman::M1 || step.target > laderman::M23) {
+					throw std::runtime_error("Could not form operands: incorrect schedule.");
+				}
+				product(step.target - laderman::M1, source(step.lhs), source(step.rhs));
+				continue;
+			}
+			if (!laderman::isTemporary(step.target) || step.target - laderman::T1 >= int(temporaries.size())) {
+				throw std::runtime_error("Could not form operands: incorrect schedule.");
+			}
+			auto& target = temporaries[step.target - laderman::T1];
+			target.combine(source(step.lhs), source(step.rhs), step.op == laderman::Op::Subtract);
+			registers[step.target] = &target;
+		}
+	}
 
+	// Assembles the result of a single Laderman step of the given size from its 23 products.
+	// With Acc other than T every C_ij is accumulated in Acc in a single pass, otherwise
+	// the schedule shares partial sums between C_ij.
+	template<typename Acc = T>
+	friend Matrix<T> ladermanAssemble(const std::vector<Matrix<T>>& M, T padding, int size,
+		std::span<const laderman::Step> schedule = laderman::assemblySchedule)
+	{
+		if (M.size() != ladermanProductCount) throw std::runtime_error("Could not assemble matrix: incorrect number of products.");
+
+		// calculated C_ij submatrices
+		Matrix<T> result(padding, size);
         auto C = result.partition(3);
-        C(0, 0) = buf.acc(M6, M14, M19);
-        C(0, 1) = buf.acc(M1, M4, M5, M6, M12, M14, M15);
-        C(0, 2) = buf.acc(M6, M7, M9, M10, M14, M16, M18);
-        C(1, 0) = buf.acc(M2, M3, M4, M6, M14, M16, M17);
-        C(1, 1) = buf.acc(M2, M4, M5, M6, M20);
-        C(1, 2) = buf.acc(M14, M16, M17, M18, M21);
-        C(2, 0) = buf.acc(M6, M7, M8, M11, M12, M13, M14);
-        C(2, 1) = buf.acc(M12, M13, M14, M15, M22);
-        C(2, 2) = buf.acc(M6, M7, M8, M9, M23);
+
+		if constexpr (!std::is_same_v<Acc, T>) {
+			for (int block = 0; block < laderman::blockCount; block++) {
+				const auto& sum = laderman::resultSums[block];
+				const Matrix<T>* terms[laderman::maxTerms];
+				for (int term = 0; term < sum.count; term++) terms[term] = &M[sum.terms[term] - laderman::M1];
+				C(block / 3, block % 3).template accumulate<Acc>(terms, sum.count);
+			}
+			return result;
+		}
+
+		std::unique_ptr<T[]> storage;
+		auto temporaries = makeTemporaries(storage, laderman::temporaryCount(schedule), M[0].m_padding, M[0].m_size);
+
+		// registers that may be written; they become readable once written
+		Matrix<T>* targets[laderman::RegisterCount] = {};
+		const Matrix<T>* registers[laderman::RegisterCount] = {};
+		for (int block = 0; block < laderman::blockCount; block++) targets[laderman::C11 + block] = &C(block / 3, block % 3);
+		for (int i = 0; i < int(temporaries.size()); i++) targets[laderman::T1 + i] = &temporaries[i];
+		auto source = [&](laderman::Register reg) -> const Matrix<T>& {
+			if (reg >= laderman::M1 && reg <= laderman::M23) return M[reg - laderman::M1];
+			if (reg < 0 || reg >= laderman::RegisterCount || registers[reg] == nullptr) throw std::runtime_error("Could not assemble matrix: incorrect schedule.");
+			return *registers[reg];
+		};
+
+		for (const auto& step : schedule) {
+			if (step.op == laderman::Op::Multiply || step.target < 0 || step.target >= laderman::RegisterCount ||
+				targets[step.target] == nullptr) {
+				throw std::runtime_error("Could not assemble matrix: incorrect schedule.");
+			}
+			targets[step.target]->combine(source(step.lhs), source(step.rhs), step.op == laderman::Op::Subtract);
+			registers[step.target] = targets[step.target];
+		}
+		for (int block = 0; block < laderman::blockCount; block++) {
+			if (registers[laderman::C11 + block] == nullptr) throw std::runtime_error("Could not assemble matrix: incorrect schedule.");
+		}
 
 		return result;
 	}
@@ -346,21 +447,49 @@ private:
 	int m_colsEnd;
 	int m_size;
 
-	Matrix<T>& acc(const Matrix<T>& tail) {
-		return *this = tail;
+	// replaces a view moved into a by-value operand with an owning copy, as copying it would
+	void materialize() {
+		if (!m_isDataOwner) *this = Matrix<T>(*this);
 	}
 
-	template<typename... Args>
-	Matrix<T>& acc(const Matrix<T>& head, const Args&... args) {
-		return acc(args...) += head;
+	// count matrices of the given size sharing a single uninitialized allocation; schedules
+	// write every temporary before reading it, so no pass is spent on zeroing
+	static std::vector<Matrix<T>> makeTemporaries(std::unique_ptr<T[]>& storage, int count, T padding, int size) {
+		storage = std::make_unique_for_overwrite<T[]>(std::size_t(count) * size * size);
+		std::vector<Matrix<T>> temporaries;
+		temporaries.reserve(count);
+		for (int i = 0; i < count; i++) {
+			temporaries.emplace_back(storage.get() + std::size_t(i) * size * size, padding, size, 0, 0, size, size, size);
+		}
+		return temporaries;
 	}
 
-	Matrix<T>& sub(const Matrix<T>& tail) {
-		return *this -= tail;
+	// sets each element to lhs + rhs (or lhs - rhs); lhs and rhs may be this matrix
+	Matrix<T>& combine(const Matrix<T>& lhs, const Matrix<T>& rhs, bool subtract) {
+		if (m_size != lhs.m_size || m_size != rhs.m_size) throw std::runtime_error("Could not add matrices: operand sizes do not match.");
+        auto rowCount = std::min({ m_rowsEnd - m_rowsStart, m_size });
+        auto colCount = std::min({ m_colsEnd - m_colsStart, m_size });
+        for (int row = 0; row < rowCount; row++) {
+            for (int col = 0; col < colCount; col++) {
+                m_data[(m_rowsStart + row) * m_dataSize + (m_colsStart + col)] = subtract ?
+                    lhs.get(row, col) - rhs.get(row, col) : lhs.get(row, col) + rhs.get(row, col);
+            }
+        }
+		return *this;
 	}
 
-	template<typename... Args>
-	Matrix<T>& sub(const Matrix<T>& head, const Args&... args) {
-		return sub(args...) -= head;
+	// sets each element to the sum of terms accumulated in Acc, rounded once
+	template<typename Acc>
+	Matrix<T>& accumulate(const Matrix<T>* const* terms, int count) {
+        auto rowCount = std::min({ m_rowsEnd - m_rowsStart, m_size });
+        auto colCount = std::min({ m_colsEnd - m_colsStart, m_size });
+        for (int row = 0; row < rowCount; row++) {
+            for (int col = 0; col < colCount; col++) {
+				Acc sum = Acc();
+				for (int term = 0; term < count; term++) sum += terms[term]->get(row, col);
+                m_data[(m_rowsStart + row) * m_dataSize + (m_colsStart + col)] = static_cast<T>(sum);
+            }
+        }
+		return *this;
 	}
 };
@@ -28,6 +28,80 @@ for THRESHOLD in {1..100}; do
 	echo "OK";
 done
 
+# --mixed stores single precision, so it is not combined with --double
+ACCUMULATIONS="--kahan"
+if [ "$4" != "--double" ]; then
+	ACCUMULATIONS="--mixed $ACCUMULATIONS"
+fi
+for ACCUMULATION in $ACCUMULATIONS; do
+	for THRESHOLD in 1 2 4 10 27; do
+		echo -n "Checking mixed Strassen3 algorithm (accumulation: $ACCUMULATION, threshold: $THRESHOLD)..."
+		$1 __correctness_test_1.txt __correctness_test_2.txt __correctness.txt $ACCUMULATION --thres $THRESHOLD $4
+		if [ $? -ne 0 ]; then
+			echo "ERROR: The mixed Strassen3 algorithm (accumulation: $ACCUMULATION, threshold: $THRESHOLD) terminated with a non-zero exit status."
+			((ERROR_COUNTER++))
+		fi
+		if ! cmp -s __correctness_trivial.txt __correctness.txt ; then
+			echo "ERROR: The mixed Strassen3 algorithm (accumulation: $ACCUMULATION, threshold: $THRESHOLD) result differs from the trivial algorithm result."
+			((ERROR_COUNTER++))
+		fi
+		echo "OK";
+	done
+done
+
+for DEPTH in {0..5}; do
+	echo -n "Checking mixed Strassen3 algorithm (depth: $DEPTH)..."
+	$1 __correctness_test_1.txt __correctness_test_2.txt __correctness.txt --depth $DEPTH $4
+	if [ $? -ne 0 ]; then
+		echo "ERROR: The mixed Strassen3 algorithm (depth: $DEPTH) terminated with a non-zero exit status."
+		((ERROR_COUNTER++))
+	fi
+	if ! cmp -s __correctness_trivial.txt __correctness.txt ; then
+		echo "ERROR: The mixed Strassen3 algorithm (depth: $DEPTH) result differs from the trivial algorithm result."
+		((ERROR_COUNTER++))
+	fi
+	echo "OK";
+done
+
+for WORKERS in {1..4}; do
+	for LEVELS in {1..2}; do
+		echo -n "Checking distributed Strassen3 algorithm (workers: $WORKERS, levels: $LEVELS)..."
+		$1 __correctness_test_1.txt __correctness_test_2.txt __correctness.txt --workers $WORKERS --levels $LEVELS --thres 10 $4 > /dev/null
+		if [ $? -ne 0 ]; then
+			echo "ERROR: The distributed Strassen3 algorithm (workers: $WORKERS, levels: $LEVELS) terminated with a non-zero exit status."
+			((ERROR_COUNTER++))
+		fi
+		if ! cmp -s __correctness_trivial.txt __correctness.txt ; then
+			echo "ERROR: The distributed Strassen3 algorithm (workers: $WORKERS, levels: $LEVELS) result differs from the trivial algorithm result."
+			((ERROR_COUNTER++))
+		fi
+		echo "OK";
+	done
+done
+
+# nodes splitting their tasks among their own local workers
+$1 --serve unix:__correctness_node_1.sock --workers 2 $4 &
+NODE_1=$!
+$1 --serve unix:__correctness_node_2.sock --workers 3 $4 &
+NODE_2=$!
+sleep 1
+for LEVELS in 1,1 1,2 2,1; do
+	echo -n "Checking distributed Strassen3 algorithm (nodes: 2, levels: $LEVELS)..."
+	$1 __correctness_test_1.txt __correctness_test_2.txt __correctness.txt --nodes unix:__correctness_node_1.sock,unix:__correctness_node_2.sock --levels $LEVELS --thres 5 $4 > /dev/null
+	if [ $? -ne 0 ]; then
+		echo "ERROR: The distributed Strassen3 algorithm (nodes: 2, levels: $LEVELS) terminated with a non-zero exit status."
+		((ERROR_COUNTER++))
+	fi
+	if ! cmp -s __correctness_trivial.txt __correctness.txt ; then
+		echo "ERROR: The distributed Strassen3 algorithm (nodes: 2, levels: $LEVELS) result differs from the trivial algorithm result."
+		((ERROR_COUNTER++))
+	fi
+	echo "OK";
+done
+kill $NODE_1 $NODE_2
+wait $NODE_1 $NODE_2 2> /dev/null
+
+rm __correctness_node_1.sock __correctness_node_2.sock
 rm __correctness_test_1.txt __correctness_test_2.txt __correctness_trivial.txt __correctness.txt
 
 if [ $ERROR_COUNTER -gt 0 ]; then
@@ -81,6 +81,48 @@ static void BM_Strassen3_200(benchmark::State& state) {
     }
 }
 
+static void BM_Strassen3_50_Mixed(benchmark::State& state) {
+    const auto size = state.range(0);
+    const auto A = getUniformMatrix(size, -10.0f, 10.0f);
+    const auto B = getUniformMatrix(size, -10.0f, 10.0f);
+
+    for (auto _ : state) {
+        auto C = strassen3<double>(A, B, 50);
+    }
+}
+
+static void BM_Strassen3_50_Kahan(benchmark::State& state) {
+    const auto size = state.range(0);
+    const auto A = getUniformMatrix(size, -10.0f, 10.0f);
+    const auto B = getUniformMatrix(size, -10.0f, 10.0f);
+
+    for (auto _ : state) {
+        auto C = strassen3<Kahan<float>>(A, B, 50);
+    }
+}
+
+// additions and subtractions of a single Laderman step (no products); passes counts every sweep
+// over a block, temporaries are allocated uninitialized so schedule steps are the only ones
+static void BM_LadermanAdditions(benchmark::State& state, std::span<const laderman::Step> operandSchedule,
+    std::span<const laderman::Step> assemblySchedule) {
+    const auto size = state.range(0);
+    const auto A = getUniformMatrix(size, -10.0f, 10.0f);
+    const auto B = getUniformMatrix(size, -10.0f, 10.0f);
+    std::vector<Matrix<float>> M;
+    for (int i = 0; i < laderman::productCount; i++) M.push_back(getUniformMatrix((size + 2) / 3, -10.0f, 10.0f));
+
+    for (auto _ : state) {
+        ladermanProducts(A, B, [](int, const Matrix<float>& lhs, const Matrix<float>& rhs) {
+            benchmark::DoNotOptimize(lhs.get(0, 0) + rhs.get(0, 0));
+        }, operandSchedule);
+        auto C = ladermanAssemble(M, 0.0f, size, assemblySchedule);
+    }
+    state.counters["passes"] = laderman::additionPasses(operandSchedule) + laderman::additionPasses(assemblySchedule);
+}
+
+constexpr auto naiveOperandSchedule = laderman::naiveOperandSchedule();
+constexpr auto naiveAssemblySchedule = laderman::naiveAssemblySchedule();
+
 int multiplier = 3;
 int start = 9;
 int end = 81;
@@ -90,4 +132,8 @@ BENCHMARK(BM_Strassen3)->RangeMultiplier(multiplier)->Range(start, end)->Setup(S
 BENCHMARK(BM_Strassen3_50)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
 BENCHMARK(BM_Strassen3_100)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
 BENCHMARK(BM_Strassen3_150)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
-BENCHMARK(BM_Strassen3_200)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
\ No newline at end of file
+BENCHMARK(BM_Strassen3_200)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
+BENCHMARK(BM_Strassen3_50_Mixed)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
+BENCHMARK(BM_Strassen3_50_Kahan)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
+BENCHMARK_CAPTURE(BM_LadermanAdditions, Shared, laderman::operandSchedule, laderman::assemblySchedule)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
+BENCHMARK_CAPTURE(BM_LadermanAdditions, Naive, naiveOperandSchedule, naiveAssemblySchedule)->RangeMultiplier(multiplier)->Range(start, end)->Setup(Setup);
\ No newline at end of file